@@ -15,12 +15,23 @@ static GBitmap *s_m2_bitmap;
 static BitmapLayer *s_warning_img_layer;
 static GBitmap *s_warning_bitmap;
 
-static TextLayer *s_time_layer_dte;
+static Layer *s_date_layer;
+static GBitmap *s_date_bitmap;
 
 static Layer *s_canvas_layer;
 
 static GFont s_time_font_dte;
 
+// date line cache: the text is laid out once per day / locale change,
+// then blitted from s_date_bitmap and the font is unloaded in between
+static char s_date_text[] = "Ddd 00 Mmm";
+static bool s_date_cache_valid = false;
+static int s_date_cache_bytes = 0;
+
+// debug - compare the TextLayer draw path with the cached bitmap blit
+//#define DATE_BENCHMARK
+#define DATE_BENCHMARK_LOOPS 100
+
 #ifdef PBL_PLATFORM_CHALK
   static int x0 = 18;
   static int y0 = 6;
@@ -33,6 +44,8 @@ static GFont s_time_font_dte;
 
 // states
 static bool lastBtStateConnected = false;
+static bool btStateKnown = false;
+static bool btConnected = false; // current state, from a peek or the quiet hours events
 static int chargeState = -1;
 
 // time decomposition
@@ -60,6 +73,17 @@ static int locale = locale_en;
 static bool hh_strip_zero = false;
 static int time_sep = time_sep_none;
 static bool repeat_vib = false;
+static bool quiet_hours = false;
+static int quiet_start = 22;
+static int quiet_end = 7;
+
+// quiet hours state and counters (persisted, not message keys)
+#define PERSIST_KEY_QUIET_TICKS 1
+#define PERSIST_KEY_QUIET_VIBES_AVOIDED 2
+
+static bool in_quiet = false;
+static int quiet_ticks = 0;
+static int quiet_vibes_avoided = 0;
 
 // days (en, fr, de, es, it)
 const char *DAYS[5][7] = { 
@@ -202,6 +226,132 @@ static void layer_update_callback(Layer *me, GContext *ctx) {
   }
 }
 
+// date font (re)loading, only needed while the cache is being built
+static void load_date_font() {
+  if (s_time_font_dte == NULL) {
+    s_time_font_dte = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_AERO_28));
+  }
+}
+
+static void unload_date_font() {
+  if (s_time_font_dte != NULL) {
+    size_t heap_before = heap_bytes_free();
+    fonts_unload_custom_font(s_time_font_dte);
+    s_time_font_dte = NULL;
+    
+    int font_bytes = (int)(heap_bytes_free() - heap_before);
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "date font unloaded: font freed = %d, cache = %d, net heap saved = %d bytes", 
+            font_bytes, s_date_cache_bytes, font_bytes - s_date_cache_bytes);
+  }
+}
+
+// copy a region of the frame buffer into the 1-bit date cache bitmap,
+// any non black pixel is set (the text is drawn white on black)
+static void copy_frame_buffer_region(GBitmap *fb, GRect rect, GBitmap *dest) {
+  bool one_bit = (gbitmap_get_format(fb) == GBitmapFormat1Bit);
+  
+  for (int y = 0; y < rect.size.h; y++) {
+    GBitmapDataRowInfo fb_row = gbitmap_get_data_row_info(fb, rect.origin.y + y);
+    GBitmapDataRowInfo dest_row = gbitmap_get_data_row_info(dest, y);
+    
+    for (int x = 0; x < rect.size.w; x++) {
+      int fb_x = rect.origin.x + x;
+      
+      // round displays only have data between min_x and max_x
+      bool set = false;
+      if ((fb_x >= fb_row.min_x) && (fb_x <= fb_row.max_x)) {
+        if (one_bit)
+          set = (fb_row.data[fb_x / 8] >> (fb_x % 8)) & 1;
+        else
+          set = (fb_row.data[fb_x] != GColorBlack.argb);
+      }
+      
+      if (set) {
+        dest_row.data[x / 8] |= (1 << (x % 8));
+      } else {
+        dest_row.data[x / 8] &= ~(1 << (x % 8));
+      }
+    }
+  }
+}
+
+// draw the date text the way the TextLayer did
+static void draw_date_text(GContext *ctx, GRect bounds) {
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+  graphics_context_set_text_color(ctx, GColorWhite);
+  graphics_draw_text(ctx, s_date_text, s_time_font_dte, bounds,
+                     GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter, NULL);
+}
+
+#ifdef DATE_BENCHMARK
+// elapsed ms since (start_s, start_ms)
+static int elapsed_ms(time_t start_s, uint16_t start_ms) {
+  time_t now_s;
+  uint16_t now_ms = time_ms(&now_s, NULL);
+  return (int)((now_s - start_s) * 1000 + now_ms - start_ms);
+}
+
+// time both draw paths over many redraws, the cache is drawn last
+static void benchmark_date_draw(GContext *ctx, GRect bounds) {
+  time_t start_s;
+  uint16_t start_ms = time_ms(&start_s, NULL);
+  for (int i = 0; i < DATE_BENCHMARK_LOOPS; i++) {
+    draw_date_text(ctx, bounds);
+  }
+  int text_ms = elapsed_ms(start_s, start_ms);
+  
+  start_ms = time_ms(&start_s, NULL);
+  for (int i = 0; i < DATE_BENCHMARK_LOOPS; i++) {
+    graphics_draw_bitmap_in_rect(ctx, s_date_bitmap, bounds);
+  }
+  int blit_ms = elapsed_ms(start_s, start_ms);
+  
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "date draw x%d: text = %d ms (%d us each), blit = %d ms (%d us each)", 
+          DATE_BENCHMARK_LOOPS, text_ms, text_ms * 1000 / DATE_BENCHMARK_LOOPS, 
+          blit_ms, blit_ms * 1000 / DATE_BENCHMARK_LOOPS);
+}
+#endif
+
+// date drawing, from the cached bitmap when possible
+static void date_layer_update_callback(Layer *me, GContext *ctx) {
+  GRect bounds = layer_get_bounds(me);
+  
+  if (s_date_cache_valid) {
+    graphics_draw_bitmap_in_rect(ctx, s_date_bitmap, bounds);
+    return;
+  }
+  
+  // lay out the text with the custom font
+  load_date_font();
+  draw_date_text(ctx, bounds);
+  
+  // rasterize it into the cache
+  GBitmap *fb = graphics_capture_frame_buffer(ctx);
+  if (fb == NULL) return;
+  
+  if (s_date_bitmap == NULL) {
+    size_t heap_before = heap_bytes_free();
+    s_date_bitmap = gbitmap_create_blank(bounds.size, GBitmapFormat1Bit);
+    s_date_cache_bytes = (int)(heap_before - heap_bytes_free());
+  }
+  
+  if (s_date_bitmap != NULL) {
+    copy_frame_buffer_region(fb, layer_get_frame(me), s_date_bitmap);
+    s_date_cache_valid = true;
+  }
+  
+  graphics_release_frame_buffer(ctx, fb);
+  
+  // the font is not needed until the next day / locale change
+  if (s_date_cache_valid) {
+    #ifdef DATE_BENCHMARK
+      benchmark_date_draw(ctx, bounds);
+    #endif
+    unload_date_font();
+  }
+}
+
 static void unload_time_images() {
   //APP_LOG(APP_LOG_LEVEL_DEBUG, "unload_time_images");
   
@@ -288,19 +438,16 @@ static void main_window_load(Window *window) {
   GRect frame = layer_get_frame(window_layer);
   
   // Create GFonts 
-  s_time_font_dte = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_AERO_28));
+  load_date_font();
 
   // Initial time (00:00)
   load_time_images();
   
-  // Create and add the time TextLayer DTE
-  s_time_layer_dte = text_layer_create(GRect(x0, y0 + 96, 144, 32));
-  text_layer_set_background_color(s_time_layer_dte, GColorBlack);
-  text_layer_set_text_color(s_time_layer_dte, GColorWhite);
-  text_layer_set_text(s_time_layer_dte, "Ddd 00 Mmm");
-  text_layer_set_font(s_time_layer_dte, s_time_font_dte);
-  text_layer_set_text_alignment(s_time_layer_dte, GTextAlignmentCenter);
-  layer_add_child(window_layer, text_layer_get_layer(s_time_layer_dte));
+  // Create and add the date Layer DTE
+  s_date_cache_valid = false;
+  s_date_layer = layer_create(GRect(x0, y0 + 96, 144, 32));
+  layer_set_update_proc(s_date_layer, date_layer_update_callback);
+  layer_add_child(window_layer, s_date_layer);
   
   // Create and add a line Canvas Layer
   s_canvas_layer = layer_create(frame);
@@ -317,10 +464,15 @@ static void main_window_load(Window *window) {
 // main window unloading (destruction)
 static void main_window_unload(Window *window) {
   // Unload font
-  fonts_unload_custom_font(s_time_font_dte);
+  unload_date_font();
 
-  // Destroy text layer
-  text_layer_destroy(s_time_layer_dte);
+  // Destroy date layer and its cache
+  layer_destroy(s_date_layer);
+  if (s_date_bitmap != NULL) {
+    gbitmap_destroy(s_date_bitmap);
+    s_date_bitmap = NULL;
+  }
+  s_date_cache_valid = false;
   
   // Destroy canvas layer
   layer_destroy(s_canvas_layer);
@@ -333,28 +485,11 @@ static void main_window_unload(Window *window) {
   gbitmap_destroy(s_warning_bitmap);
 }
 
-// update display
-static void update_display() {
-  // Getting Battery State
-  BatteryChargeState current_battery_charge_state = battery_state_service_peek();
-  
-  if (current_battery_charge_state.is_charging) {
-    chargeState = -1;
-  }
-  else {
-    chargeState = current_battery_charge_state.charge_percent;
-  }
-  
-  //APP_LOG(APP_LOG_LEVEL_DEBUG, "Setting chargeState = %d", chargeState);
-  
-  // Get a tm structure
-  time_t temp = time(NULL); 
-  struct tm *tick_time = localtime(&temp);
-  
+// update time digits only
+static void update_time(struct tm *tick_time) {
   // Create a long-lived buffers
   static char buffer_hh[] = "00";
   static char buffer_mm[] = "00";
-  static char buffer_dte[] = "ddd 00 mmm";
   
   // Write the current hours into the buffer
   if(clock_is_24h_style() == true) {
@@ -380,6 +515,16 @@ static void update_display() {
   // debug
   //h1 = h2 = m1 = m2 = 0;
   
+  // undload and relaod time images
+  unload_time_images();
+  load_time_images();
+}
+
+// update date line, the cache is rebuilt only when the text changed (day or locale)
+static void update_date(struct tm *tick_time) {
+  // Create a long-lived buffer
+  static char buffer_dte[] = "ddd 00 mmm";
+  
   // Write the current date into the buffer
   if (locale != locale_en) {
     // Ddd 00 Mmm
@@ -392,22 +537,44 @@ static void update_display() {
     snprintf(buffer_dte, sizeof("ddd mmm 00"), "%s %s %d", DAYS[0][tick_time->tm_wday], MONTHS[0][tick_time->tm_mon], tick_time->tm_mday);
   }
   
-  // undload and relaod time images
-  unload_time_images();
-  load_time_images();
+  if (strcmp(buffer_dte, s_date_text) != 0) {
+    strncpy(s_date_text, buffer_dte, sizeof(s_date_text));
+    s_date_cache_valid = false;
+    layer_mark_dirty(s_date_layer);
+  }
+}
+
+// update display
+static void update_display(struct tm *tick_time) {
+  // Getting Battery State
+  BatteryChargeState current_battery_charge_state = battery_state_service_peek();
+  
+  if (current_battery_charge_state.is_charging) {
+    chargeState = -1;
+  }
+  else {
+    chargeState = current_battery_charge_state.charge_percent;
+  }
   
-  // Display values in TextLayers
-  text_layer_set_text(s_time_layer_dte, buffer_dte);
+  //APP_LOG(APP_LOG_LEVEL_DEBUG, "Setting chargeState = %d", chargeState);
+  
+  // Time digits and date
+  update_time(tick_time);
+  update_date(tick_time);
   
   if (connection_service_peek_pebble_app_connection()) {
     // phone is connected
     layer_set_hidden(bitmap_layer_get_layer(s_warning_img_layer), true); 
-    //layer_set_hidden(text_layer_get_layer(s_time_layer_dte), false); 
+    //layer_set_hidden(s_date_layer, false); 
     lastBtStateConnected = true;
+    btStateKnown = true;
+    btConnected = true;
   } else {
     // phone is not connected
-    //layer_set_hidden(text_layer_get_layer(s_time_layer_dte), true); 
+    //layer_set_hidden(s_date_layer, true); 
     layer_set_hidden(bitmap_layer_get_layer(s_warning_img_layer), false); 
+    btStateKnown = true;
+    btConnected = false;
     
     // if we just lost the connection or if we want to have repeated vibrations, vibe twice
     if (lastBtStateConnected || repeat_vib) {
@@ -417,8 +584,82 @@ static void update_display() {
   }
 }
 
+// quiet hours window check, the window may wrap around midnight
+static bool is_quiet_time(int hour) {
+  if (!quiet_hours || quiet_start == quiet_end) return false;
+  
+  if (quiet_start < quiet_end)
+    return (hour >= quiet_start) && (hour < quiet_end);
+  else
+    return (hour >= quiet_start) || (hour < quiet_end);
+}
+
+static void save_quiet_counters() {
+  persist_write_int(PERSIST_KEY_QUIET_TICKS, quiet_ticks);
+  persist_write_int(PERSIST_KEY_QUIET_VIBES_AVOIDED, quiet_vibes_avoided);
+  
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "quiet counters: reduced ticks = %d, vibes avoided = %d", 
+          quiet_ticks, quiet_vibes_avoided);
+}
+
+// BT state during quiet hours: warning only, no vibration
+static void quiet_connection_handler(bool connected) {
+  btConnected = connected;
+  btStateKnown = true;
+  layer_set_hidden(bitmap_layer_get_layer(s_warning_img_layer), connected);
+}
+
+// refresh display, full or reduced depending on quiet hours
+// (is_tick is false at launch and after a configuration change)
+static void refresh_display(struct tm *tick_time, bool is_tick) {
+  if (is_quiet_time(tick_time->tm_hour)) {
+    if (!in_quiet) {
+      APP_LOG(APP_LOG_LEVEL_DEBUG, "entering quiet hours");
+      in_quiet = true;
+      
+      // BT changes come from events instead of a peek at each tick
+      connection_service_subscribe((ConnectionHandlers) {
+        .pebble_app_connection_handler = quiet_connection_handler
+      });
+    }
+    
+    // reduced schedule: digits only, no battery / date refresh, no BT peek / vibration
+    update_time(tick_time);
+    
+    if (!is_tick) {
+      // launch or new settings: draw the date line and peek BT once, without vibration
+      update_date(tick_time);
+      quiet_connection_handler(connection_service_peek_pebble_app_connection());
+      lastBtStateConnected = btConnected;
+      return;
+    }
+    
+    quiet_ticks++;
+    
+    // count the vibration update_display() would have fired at this tick
+    if (btStateKnown) {
+      if (btConnected) {
+        lastBtStateConnected = true;
+      } else {
+        if (lastBtStateConnected || repeat_vib) quiet_vibes_avoided++;
+        lastBtStateConnected = false;
+      }
+    }
+  }
+  else {
+    if (in_quiet) {
+      APP_LOG(APP_LOG_LEVEL_DEBUG, "leaving quiet hours");
+      in_quiet = false;
+      connection_service_unsubscribe();
+      save_quiet_counters();
+    }
+    
+    update_display(tick_time);
+  }
+}
+
 static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
-  update_display();
+  refresh_display(tick_time, true);
 }
 
 void read_configuration(void)
@@ -478,6 +719,42 @@ void read_configuration(void)
     repeat_vib = persist_read_bool(MESSAGE_KEY_REPEAT_VIB);
     APP_LOG(APP_LOG_LEVEL_DEBUG, "repeat_vib = %d", repeat_vib);
   }
+  
+  if (persist_exists(MESSAGE_KEY_QUIET_HOURS))
+  {
+    quiet_hours = persist_read_bool(MESSAGE_KEY_QUIET_HOURS);
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "quiet_hours = %d", quiet_hours);
+  }
+  
+  if (persist_exists(MESSAGE_KEY_QUIET_START))
+  {
+    quiet_start = persist_read_int(MESSAGE_KEY_QUIET_START);
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "quiet_start = %d", quiet_start);
+  }
+  
+  if (persist_exists(MESSAGE_KEY_QUIET_END))
+  {
+    quiet_end = persist_read_int(MESSAGE_KEY_QUIET_END);
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "quiet_end = %d", quiet_end);
+  }
+}
+
+// hour (0-23) from a config string of 1 or 2 digits, or fallback if invalid
+static int parse_hour(const Tuple *tuple, int fallback) {
+  if (tuple->type != TUPLE_CSTRING) return fallback;
+  
+  const char *str = tuple->value->cstring;
+  int d1 = ascii_digit_to_int(str[0]);
+  if (d1 < 0) return fallback;
+  
+  int hour = d1;
+  if (str[1] != '\0') {
+    int d2 = ascii_digit_to_int(str[1]);
+    if ((d2 < 0) || (str[2] != '\0')) return fallback;
+    hour = d1 * 10 + d2;
+  }
+  
+  return (hour <= 23) ? hour : fallback;
 }
 
 void in_received_handler(DictionaryIterator *received, void *context)
@@ -628,9 +905,54 @@ void in_received_handler(DictionaryIterator *received, void *context)
       persist_write_bool(MESSAGE_KEY_REPEAT_VIB, false);
     }
   }  
+  
+  Tuple *quiet_hours_tuple = dict_find(received, MESSAGE_KEY_QUIET_HOURS);
+  if (quiet_hours_tuple)
+  {
+    app_log(APP_LOG_LEVEL_DEBUG,
+            __FILE__,
+            __LINE__,
+            "quiet_hours=%s",
+            quiet_hours_tuple->value->cstring);
+
+    if (strcmp(quiet_hours_tuple->value->cstring, "1") == 0)
+    {
+      persist_write_bool(MESSAGE_KEY_QUIET_HOURS, true);
+    }
+    else
+    {
+      persist_write_bool(MESSAGE_KEY_QUIET_HOURS, false);
+    }
+  }
+  
+  Tuple *quiet_start_tuple = dict_find(received, MESSAGE_KEY_QUIET_START);
+  if (quiet_start_tuple)
+  {
+    app_log(APP_LOG_LEVEL_DEBUG,
+            __FILE__,
+            __LINE__,
+            "quiet_start=%s",
+            quiet_start_tuple->value->cstring);
+
+    persist_write_int(MESSAGE_KEY_QUIET_START, parse_hour(quiet_start_tuple, quiet_start));
+  }
+  
+  Tuple *quiet_end_tuple = dict_find(received, MESSAGE_KEY_QUIET_END);
+  if (quiet_end_tuple)
+  {
+    app_log(APP_LOG_LEVEL_DEBUG,
+            __FILE__,
+            __LINE__,
+            "quiet_end=%s",
+            quiet_end_tuple->value->cstring);
+
+    persist_write_int(MESSAGE_KEY_QUIET_END, parse_hour(quiet_end_tuple, quiet_end));
+  }
 
   read_configuration();
-  update_display();
+  
+  time_t temp = time(NULL); 
+  refresh_display(localtime(&temp), false);
 }
 
 
@@ -647,11 +969,15 @@ void in_dropped_handler(AppMessageResult reason, void *ctx)
 static void init() {
   // read configuration 
   read_configuration();
+  
+  // read quiet hours counters
+  if (persist_exists(PERSIST_KEY_QUIET_TICKS)) quiet_ticks = persist_read_int(PERSIST_KEY_QUIET_TICKS);
+  if (persist_exists(PERSIST_KEY_QUIET_VIBES_AVOIDED)) quiet_vibes_avoided = persist_read_int(PERSIST_KEY_QUIET_VIBES_AVOIDED);
     
   // register configurable messages
   app_message_register_inbox_received(in_received_handler);
   app_message_register_inbox_dropped(in_dropped_handler);
-  app_message_open(64, 64);
+  app_message_open(128, 64);
   
   // Create main Window element
   s_main_window = window_create();
@@ -667,7 +993,8 @@ static void init() {
   window_stack_push(s_main_window, true);
   
   // Make sure the time is displayed from the start
-  update_display();
+  time_t temp = time(NULL); 
+  refresh_display(localtime(&temp), false);
   
   // Register with TickTimerService
   tick_timer_service_subscribe(MINUTE_UNIT, tick_handler);
@@ -680,6 +1007,10 @@ static void deinit() {
   
   // Untergister services
   tick_timer_service_unsubscribe();
+  if (in_quiet) connection_service_unsubscribe();
+  
+  // keep quiet hours counters
+  save_quiet_counters();
   
   // Destroy Window
   window_destroy(s_main_window);
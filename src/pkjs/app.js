@@ -8,6 +8,67 @@ function appMessageNack(e) {
     console.log("options not sent to Pebble: " + e.error.message);
 }
 
+// configuration page, opened as a data URI (see showConfiguration)
+// all values are sent back as strings, as expected by in_received_handler
+
+function config_select(id, label, choices) {
+  var html = '<p><label for="' + id + '">' + label + '</label><br><select id="' + id + '">';
+  for (var i = 0; i < choices.length; i++) {
+    html += '<option value="' + choices[i][0] + '">' + choices[i][1] + '</option>';
+  }
+  html += '</select></p>';
+  return html;
+}
+
+function config_hours() {
+  var choices = [];
+  for (var h = 0; h < 24; h++) {
+    choices.push([String(h), (h < 10 ? '0' : '') + h + ':00']);
+  }
+  return choices;
+}
+
+function config_page(options) {
+  var yes_no = [["1", "Yes"], ["0", "No"]];
+
+  var html = '<!DOCTYPE html><html><head><meta charset="utf-8">' +
+    '<meta name="viewport" content="width=device-width, initial-scale=1">' +
+    '<title>MySimpleWatch</title>' +
+    '<style>body{font-family:sans-serif;background:#000;color:#fff;padding:8px}' +
+    'select,button{width:100%;font-size:1em;padding:6px}</style></head><body>' +
+    '<h2>MySimpleWatch</h2>';
+
+  html += config_select("hh-in-bold", "Hours in bold", yes_no);
+  html += config_select("mm-in-bold", "Minutes in bold", yes_no);
+  html += config_select("hh-strip-zero", "Hide hours leading zero", yes_no);
+  html += config_select("time-sep", "Time separator",
+    [["none", "None"], ["square", "Square"], ["round", "Round"], ["squareb", "Square bold"], ["roundb", "Round bold"]]);
+  html += config_select("locale", "Language",
+    [["default", "Default"], ["en", "English"], ["fr", "Français"], ["de", "Deutsch"], ["es", "Español"], ["it", "Italiano"]]);
+  html += config_select("repeat-vib", "Repeat vibration when disconnected", yes_no);
+  html += config_select("quiet-hours", "Quiet hours", yes_no);
+  html += config_select("quiet-start", "Quiet hours start", config_hours());
+  html += config_select("quiet-end", "Quiet hours end", config_hours());
+
+  html += '<button id="save">Save</button>' +
+    '<script>' +
+    'var options = ' + JSON.stringify(options) + ';' +
+    'var defaults = {"hh-in-bold":"1", "mm-in-bold":"0", "hh-strip-zero":"0", "time-sep":"none", "locale":"default", ' +
+    '"repeat-vib":"0", "quiet-hours":"0", "quiet-start":"22", "quiet-end":"7"};' +
+    'var ids = Object.keys(defaults);' +
+    'ids.forEach(function(id) {' +
+    '  document.getElementById(id).value = (options[id] !== undefined) ? String(options[id]) : defaults[id];' +
+    '});' +
+    'document.getElementById("save").addEventListener("click", function() {' +
+    '  var result = {};' +
+    '  ids.forEach(function(id) { result[id] = document.getElementById(id).value; });' +
+    '  document.location = "pebblejs://close#" + encodeURIComponent(JSON.stringify(result));' +
+    '});' +
+    '</script></body></html>';
+
+  return html;
+}
+
 Pebble.addEventListener("ready", function() {
   console.log("PebbleKit JS ready!");
   initialized = true;
@@ -24,8 +85,8 @@ Pebble.addEventListener("showConfiguration", function() {
     console.log("defaults options: " + JSON.stringify(options));
   }
   
-  var uri = 'http://jnoelg.github.io/MySimpleWatch/configurable-3.8.html';
-  uri = uri+ '?' + encodeURIComponent(JSON.stringify(options));
+  // the page (config_page above) ships with the app so it always has every setting
+  var uri = 'data:text/html;charset=utf-8,' + encodeURIComponent(config_page(options));
   
   console.log("showing configuration");
   Pebble.openURL(uri);
@@ -35,38 +96,38 @@ Pebble.addEventListener("webviewclosed", function(e) {
   console.log("configuration closed");
   // webview closed
   // using primitive JSON validity and non-empty check
-  if (e.response.charAt(0) == "{" && e.response.slice(-1) == "}" && e.response.length > 5) {
-    var options = JSON.parse(decodeURIComponent(e.response));
+  var response = decodeURIComponent(e.response || "");
+  if (response.charAt(0) == "{" && response.slice(-1) == "}" && response.length > 5) {
+    var options = JSON.parse(response);
     console.log("storing options: " + JSON.stringify(options));
     localStorage.setItem('options', JSON.stringify(options));
     
-    var hh_in_bold = options["hh-in-bold"];
-    console.log("hh-in-bold: " + hh_in_bold);
-    
-    var mm_in_bold = options["mm-in-bold"];
-    console.log("mm-in-bold: " + mm_in_bold);
-    
-    var locale = options.locale;
-    console.log("locale: " + locale);
-    
-    var hh_strip_zero = options["hh-strip-zero"];
-    console.log("hh-strip-zero: " + hh_strip_zero);
-    
-    var time_sep = options["time-sep"];
-    console.log("time-sep: " + time_sep);
+    // message keys for each option, all sent as strings
+    var keys = {
+      "hh-in-bold":"HH_IN_BOLD",
+      "mm-in-bold":"MM_IN_BOLD", 
+      "locale":"LOCALE",
+      "hh-strip-zero":"HH_STRIP_ZERO", 
+      "time-sep":"TIME_SEP", 
+      "repeat-vib":"REPEAT_VIB", 
+      "quiet-hours":"QUIET_HOURS", 
+      "quiet-start":"QUIET_START", 
+      "quiet-end":"QUIET_END"
+    };
     
-    var repeat_vib = options["repeat-vib"];
-    console.log("repeat-vib: " + repeat_vib);
+    var message = {};
+    for (var option in keys) {
+      var value = options[option];
+      console.log(option + ": " + value);
+      
+      // options missing from the page are not sent
+      if (value !== undefined && value !== null) {
+        message[keys[option]] = String(value);
+      }
+    }
     
     Pebble.sendAppMessage(
-      {
-        "HH_IN_BOLD":hh_in_bold,
-        "MM_IN_BOLD":mm_in_bold, 
-        "LOCALE":locale,
-        "HH_STRIP_ZERO":hh_strip_zero, 
-        "TIME_SEP":time_sep, 
-        "REPEAT_VIB":repeat_vib
-      }, 
+      message, 
       appMessageAck, 
       appMessageNack
     );